@@ -1,5 +1,12 @@
 #include "FreqDomainConvolver.h"
 
+#include <algorithm>
+
+namespace {
+// Overlap peak (-140 dB) below which the remaining tail counts as decayed
+constexpr float silenceLevel = 1.0e-7f;
+} // namespace
+
 FreqDomainConvolver::FreqDomainConvolver(const std::vector<float> &h,
                                          int fftOrder = 10, int blockSize = 128)
     : fftOrder(fftOrder), K(1 << fftOrder), B(blockSize), N((int)h.size()),
@@ -22,9 +29,23 @@ FreqDomainConvolver::FreqDomainConvolver(const std::vector<float> &h,
   jassert(Henergy > 0.0); // IR actually made it into the spectrum
 }
 
+FreqDomainConvolver::FreqDomainConvolver(int irLength,
+                                         const Spectrum &irSpectrum,
+                                         int fftOrder, int blockSize)
+    : fftOrder(fftOrder), K(1 << fftOrder), B(blockSize), N(irLength),
+      fft(fftOrder), Hspec(irSpectrum), Xspec(K), Yspec(K), timeC(K),
+      timeK(K, 0.0f) {
+  jassert(N > 0);
+  jassert(K >= B + N - 1);           // OLA no-aliasing requirement
+  jassert((int)Hspec.size() == K);   // spectrum was taken at this FFT size
+
+  overlap.assign((size_t)(N - 1), 0.0f);
+}
+
 void FreqDomainConvolver::reset() {
   std::fill(overlap.begin(), overlap.end(), 0.0f);
   overlap.assign((size_t)(N - 1), 0.0f);
+  tailRemaining = 0;
 }
 
 std::vector<float> FreqDomainConvolver::processBlock(const float *x,
@@ -32,6 +53,41 @@ std::vector<float> FreqDomainConvolver::processBlock(const float *x,
   // Ensure B is valid size (not smaller)
   jassert(numSamples > 0 && numSamples <= B);
 
+  // Ensure overlap is exactly N-1 long (clipping prevention)
+  if ((int)overlap.size() != N - 1)
+    overlap.assign((size_t)(N - 1), 0.0f);
+
+  // Silent input has a silent spectrum: skip FFT/MAC/IFFT and just drain the
+  // overlap carried from earlier blocks
+  const bool silent =
+      std::all_of(x, x + numSamples, [](float s) { return s == 0.0f; });
+  if (silent) {
+    std::vector<float> y((size_t)numSamples, 0.0f);
+    if (tailRemaining == 0)
+      return y;
+
+    const int drained = std::min(numSamples, N - 1);
+    std::copy(overlap.begin(), overlap.begin() + drained, y.begin());
+
+    // Shift the rest down, watching its level on the way
+    float peak = 0.0f;
+    for (int t = 0; t < N - 1 - drained; ++t) {
+      const float v = overlap[(size_t)(t + drained)];
+      overlap[(size_t)t] = v;
+      peak = std::max(peak, std::abs(v));
+    }
+    std::fill(overlap.end() - drained, overlap.end(), 0.0f);
+
+    tailRemaining = std::max(0, tailRemaining - numSamples);
+
+    // Once what's left is inaudible, drop it and stop touching the overlap
+    if (peak < silenceLevel && tailRemaining > 0) {
+      std::fill(overlap.begin(), overlap.end(), 0.0f);
+      tailRemaining = 0;
+    }
+    return y;
+  }
+
   // 1. TD -> FD (FFT)
   for (int n = 0; n < K; ++n)
     timeC[n] = (n < numSamples ? C(x[n], 0.0f) : C(0.0f, 0.0f));
@@ -51,10 +107,6 @@ std::vector<float> FreqDomainConvolver::processBlock(const float *x,
   const int tail = valid - head;        // samples to carry
   jassert(valid <= K && tail >= 0 && tail <= (N - 1));
 
-  // Ensure overlap is exactly N-1 long (clipping prevention)
-  if ((int)overlap.size() != N - 1)
-    overlap.assign((size_t)(N - 1), 0.0f);
-
   // 4. Build output head = current head + previous overlap
   std::vector<float> y((size_t)head);
   for (int n = 0; n < head; ++n) {
@@ -79,6 +131,7 @@ std::vector<float> FreqDomainConvolver::processBlock(const float *x,
     newOverlap[(size_t)t] += timeC[head + t].real() * invK;
 
   overlap.swap(newOverlap); // Box it
+  tailRemaining = N - 1;
   return y;                 // Ship it
 }
 
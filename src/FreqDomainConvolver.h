@@ -7,9 +7,14 @@
 class FreqDomainConvolver
 {
 public:
+    using Spectrum = std::vector<juce::dsp::Complex<float>>;
+
     // fftOrder=10 -> K=1024, blockSize=128 by your spec
     FreqDomainConvolver(const std::vector<float>& h, int fftOrder, int blockSize);
 
+    // Rebuild from a spectrum saved with getIRSpectrum(), skipping the IR FFT
+    FreqDomainConvolver(int irLength, const Spectrum& irSpectrum, int fftOrder, int blockSize);
+
     void reset();
 
     // Process one block (numSamples can be < B for the final block)
@@ -25,6 +30,12 @@ public:
     int getBlockSize() const { return B; }
     int getIRLength()  const { return N; }
 
+    const Spectrum& getIRSpectrum() const { return Hspec; }
+
+    // True once the overlap carry is all zeros: either fully emitted, or
+    // flushed after its level fell below -140 dB
+    bool isIdle() const { return tailRemaining == 0; }
+
 private:
     const int fftOrder;    // dsp::fft requirement
     const int K;           // FFT size
@@ -40,4 +51,7 @@ private:
     // Time-domain working buffer (K real samples) and carry buffer (K)
     std::vector<float> timeK;
     std::vector<float> overlap;
+
+    // Samples of overlap that may still be non-zero
+    int tailRemaining = 0;
 };
@@ -0,0 +1,166 @@
+#include "IRCache.h"
+
+#include <algorithm>
+
+namespace {
+// Bump whenever IR analysis or resampling changes what a cached spectrum
+// would contain, so stale entries stop matching
+constexpr int cacheVersion = 1;
+constexpr int fileMagic = 0x49524331; // "IRC1"
+} // namespace
+
+IRCache::IRCache(juce::File dir, juce::int64 maxSizeBytes)
+    : directory(std::move(dir)), maxBytes(maxSizeBytes) {}
+
+juce::File IRCache::getDefaultDirectory() {
+  return juce::File::getSpecialLocation(
+             juce::File::userApplicationDataDirectory)
+      .getChildFile("TaimBak")
+      .getChildFile("SpectralConvolver")
+      .getChildFile("Cache");
+}
+
+juce::String IRCache::hashSamples(const std::vector<float> &ir) {
+  return juce::SHA256(ir.data(), ir.size() * sizeof(float)).toHexString();
+}
+
+juce::String IRCache::makeSpectrumKey(const juce::String &irHash,
+                                      const juce::String &descriptor) {
+  const auto text =
+      irHash + "|" + descriptor + "|v" + juce::String(cacheVersion);
+  return juce::SHA256(text.toUTF8()).toHexString();
+}
+
+bool IRCache::loadSamples(const juce::String &irHash,
+                          std::vector<float> &ir) const {
+  if (irHash.isEmpty())
+    return false;
+
+  std::vector<float> data;
+  if (!readFloats(directory.getChildFile(irHash + ".ir"), data))
+    return false;
+
+  // Never trust a cache entry that doesn't match its name
+  if (hashSamples(data) != irHash)
+    return false;
+
+  ir.swap(data);
+  return true;
+}
+
+void IRCache::storeSamples(const juce::String &irHash,
+                           const std::vector<float> &ir) const {
+  if (irHash.isEmpty() || ir.empty())
+    return;
+
+  const auto file = directory.getChildFile(irHash + ".ir");
+  if (!file.existsAsFile())
+    writeFloats(file, ir.data(), ir.size());
+}
+
+bool IRCache::loadSpectrum(const juce::String &key, int fftSize,
+                           FreqDomainConvolver::Spectrum &spectrum) const {
+  std::vector<float> data;
+  if (!readFloats(directory.getChildFile(key + ".spec"), data))
+    return false;
+
+  if (data.size() != (size_t)fftSize * 2)
+    return false;
+
+  spectrum.resize((size_t)fftSize);
+  for (size_t k = 0; k < spectrum.size(); ++k)
+    spectrum[k] = {data[2 * k], data[2 * k + 1]};
+
+  return true;
+}
+
+void IRCache::storeSpectrum(
+    const juce::String &key,
+    const FreqDomainConvolver::Spectrum &spectrum) const {
+  std::vector<float> data;
+  data.reserve(spectrum.size() * 2);
+  for (const auto &c : spectrum) {
+    data.push_back(c.real());
+    data.push_back(c.imag());
+  }
+
+  writeFloats(directory.getChildFile(key + ".spec"), data.data(), data.size());
+}
+
+bool IRCache::readFloats(const juce::File &file,
+                         std::vector<float> &data) const {
+  juce::FileInputStream in(file);
+  if (!in.openedOk())
+    return false;
+
+  if (in.readInt() != fileMagic)
+    return false;
+
+  const auto count = in.readInt64();
+  const auto bytes = count * (juce::int64)sizeof(float);
+  if (count <= 0 || bytes != in.getNumBytesRemaining())
+    return false;
+
+  data.resize((size_t)count);
+  if (in.read(data.data(), (int)bytes) != (int)bytes)
+    return false;
+
+  // Access time is the recency used for eviction; set it explicitly since
+  // many filesystems don't update it on read
+  file.setLastAccessTime(juce::Time::getCurrentTime());
+  return true;
+}
+
+void IRCache::writeFloats(const juce::File &file, const float *data,
+                          size_t count) const {
+  if (directory.createDirectory().failed())
+    return;
+
+  // Other instances may be reading the same entry; write beside it and
+  // swap it in whole. Hidden, so trim() never sees a half-written entry.
+  juce::TemporaryFile temp(file, juce::TemporaryFile::useHiddenFile);
+  {
+    juce::FileOutputStream out(temp.getFile());
+    if (!out.openedOk())
+      return;
+
+    out.writeInt(fileMagic);
+    out.writeInt64((juce::int64)count);
+    out.write(data, count * sizeof(float));
+  }
+
+  if (temp.overwriteTargetFileWithTemporary()) {
+    file.setLastAccessTime(juce::Time::getCurrentTime());
+    trim(file);
+  }
+}
+
+void IRCache::trim(const juce::File &justWritten) const {
+  auto entries = directory.findChildFiles(
+      juce::File::findFiles | juce::File::ignoreHiddenFiles, false,
+      "*.ir;*.spec");
+
+  juce::int64 total = 0;
+  for (const auto &entry : entries)
+    total += entry.getSize();
+
+  if (total <= maxBytes)
+    return;
+
+  // Least recently used first
+  std::sort(entries.begin(), entries.end(),
+            [](const juce::File &a, const juce::File &b) {
+              return a.getLastAccessTime() < b.getLastAccessTime();
+            });
+
+  for (const auto &entry : entries) {
+    if (total <= maxBytes)
+      break;
+    if (entry == justWritten)
+      continue;
+
+    const auto size = entry.getSize();
+    if (entry.deleteFile())
+      total -= size;
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "FreqDomainConvolver.h"
+#include <vector>
+
+// On-disk cache shared by every plugin instance. Decoded IR samples are
+// stored by content hash, and IR spectra by a key derived from that hash
+// plus whatever shaped the segment, so restoring a session skips both the
+// audio file decode and the IR FFTs. Once the directory grows past its
+// size cap, the least recently used entries are deleted.
+class IRCache
+{
+public:
+    static constexpr juce::int64 defaultMaxBytes = 256 * 1024 * 1024;
+
+    explicit IRCache (juce::File directory = getDefaultDirectory(),
+                      juce::int64 maxBytes = defaultMaxBytes);
+
+    static juce::File getDefaultDirectory();
+
+    // SHA-256 of the raw sample data, as hex
+    static juce::String hashSamples (const std::vector<float>& ir);
+
+    // Key for one spectrum of one IR; descriptor covers the sample rate,
+    // block size, segment and anything else it was derived with
+    static juce::String makeSpectrumKey (const juce::String& irHash,
+                                         const juce::String& descriptor);
+
+    bool loadSamples (const juce::String& irHash, std::vector<float>& ir) const;
+    void storeSamples (const juce::String& irHash, const std::vector<float>& ir) const;
+
+    bool loadSpectrum (const juce::String& key, int fftSize,
+                       FreqDomainConvolver::Spectrum& spectrum) const;
+    void storeSpectrum (const juce::String& key,
+                        const FreqDomainConvolver::Spectrum& spectrum) const;
+
+private:
+    bool readFloats (const juce::File& file, std::vector<float>& data) const;
+    void writeFloats (const juce::File& file, const float* data, size_t count) const;
+
+    // Delete least recently used entries until the cache fits under maxBytes
+    void trim (const juce::File& justWritten) const;
+
+    juce::File directory;
+    juce::int64 maxBytes;
+};
@@ -0,0 +1,378 @@
+#include "LateReverbGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    // Octave bands used for the decay estimate
+    constexpr std::array<float, 7> octaveCentres { 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f };
+    // Bands at or below this are averaged into the low-frequency decay
+    constexpr float lowBandLimit = 500.0f;
+
+    // Mutually prime-ish line lengths, so echoes don't pile up on a common period
+    constexpr std::array<double, 8> lineLengthsMs { 29.7, 37.1, 41.1, 43.7, 53.0, 59.3, 67.1, 73.9 };
+
+    // Series allpass input diffusers (delay in ms, gain), after Dattorro's
+    // plate, so each input sample reaches the lines as a dense burst
+    constexpr std::array<std::pair<double, float>, 4> diffuserSettings { { { 4.77, 0.75f }, { 3.60, 0.75f },
+                                                                           { 12.73, 0.625f }, { 9.31, 0.625f } } };
+
+    // Input signs per line. Not a Hadamard row, so the first feedback pass
+    // already spreads an impulse over half the lines instead of one.
+    constexpr std::array<float, 8> inputSigns { 1.0f, 1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f, -1.0f };
+
+    // The network starts this long before the onset so its echo density has
+    // built up by the time it takes over; the head is crossfaded against it
+    // over the same span
+    constexpr double buildUpSeconds     = 0.1;
+    constexpr double calibrationSeconds = 0.05;
+    // Energy envelopes driving the crossfade are smoothed over this span
+    constexpr double envelopeSeconds    = 0.02;
+    constexpr float  fallbackRT60       = 1.0f;
+    // Output level (-140 dB) below which the tail counts as decayed
+    constexpr float  silenceLevel       = 1.0e-7f;
+
+    // RBJ constant-peak band-pass, run in place over the whole signal
+    void bandPass(std::vector<float>& x, float centre, double sampleRate)
+    {
+        const double w0    = 2.0 * pi * centre / sampleRate;
+        const double alpha = std::sin(w0) / (2.0 * std::sqrt(2.0));
+        const double a0    = 1.0 + alpha;
+        const double b0    = alpha / a0;
+        const double b2    = -alpha / a0;
+        const double a1    = -2.0 * std::cos(w0) / a0;
+        const double a2    = (1.0 - alpha) / a0;
+
+        double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+        for (auto& s : x)
+        {
+            const double y = b0 * s + b2 * x2 - a1 * y1 - a2 * y2;
+            x2 = x1; x1 = s;
+            y2 = y1; y1 = y;
+            s = (float)y;
+        }
+    }
+
+    // Fit a line to the Schroeder energy decay curve between -5 dB and
+    // -25 dB (T20), falling back to -15 dB (T10) for short or noisy IRs.
+    // Returns 0 if neither range is reached.
+    float estimateRT60(const std::vector<float>& x, double sampleRate)
+    {
+        std::vector<double> edc(x.size());
+        double acc = 0.0;
+        for (std::size_t n = x.size(); n-- > 0;)
+        {
+            acc += (double)x[n] * x[n];
+            edc[n] = acc;
+        }
+        if (acc <= 0.0)
+            return 0.0f;
+
+        for (const double endDb : { -25.0, -15.0 })
+        {
+            double sumT = 0.0, sumD = 0.0, sumTT = 0.0, sumTD = 0.0;
+            std::size_t count = 0;
+            bool reachedEnd = false;
+
+            for (std::size_t n = 0; n < edc.size(); n += 16)
+            {
+                const double db = 10.0 * std::log10(std::max(edc[n] / acc, 1e-30));
+                if (db > -5.0)
+                    continue;
+                if (db < endDb)
+                {
+                    reachedEnd = true;
+                    break;
+                }
+                const double t = (double)n / sampleRate;
+                sumT += t; sumD += db; sumTT += t * t; sumTD += t * db;
+                count++;
+            }
+
+            if (!reachedEnd || count < 2)
+                continue;
+
+            const double n = (double)count;
+            const double denom = n * sumTT - sumT * sumT;
+            if (denom <= 0.0)
+                continue;
+
+            const double slope = (n * sumTD - sumT * sumD) / denom;   // dB per second
+            if (slope < 0.0)
+                return (float)(-60.0 / slope);
+        }
+
+        return 0.0f;
+    }
+
+    // Energy of x around each sample in [begin, end), summed over a centred
+    // window of span samples and clipped to the signal
+    std::vector<double> energyEnvelope(const std::vector<float>& x, std::size_t begin, std::size_t end, std::size_t span)
+    {
+        const std::size_t half = span / 2;
+        const std::size_t from = begin > half ? begin - half : 0;
+        const std::size_t to   = std::min(x.size(), end + half + 1);
+
+        std::vector<double> prefix(to - from + 1, 0.0);
+        for (std::size_t n = from; n < to; n++)
+            prefix[n - from + 1] = prefix[n - from] + (double)x[n] * x[n];
+
+        std::vector<double> env(end - begin);
+        for (std::size_t n = begin; n < end; n++)
+        {
+            const std::size_t lo = std::max(from, n > half ? n - half : 0);
+            const std::size_t hi = std::min(to, n + half + 1);
+            env[n - begin] = prefix[hi - from] - prefix[lo - from];
+        }
+        return env;
+    }
+
+    // Per-pass gain of a delay of `samples` for a given RT60
+    double decayGain(double samples, double rt60, double sampleRate)
+    {
+        return std::pow(10.0, -3.0 * samples / (rt60 * sampleRate));
+    }
+
+    // Unnormalised in-place Walsh-Hadamard transform of 8 values
+    void hadamard(std::array<float, 8>& v)
+    {
+        for (std::size_t h = 1; h < v.size(); h *= 2)
+            for (std::size_t i = 0; i < v.size(); i += 2 * h)
+                for (std::size_t j = i; j < i + h; j++)
+                {
+                    const float a = v[j];
+                    const float b = v[j + h];
+                    v[j]     = a + b;
+                    v[j + h] = a - b;
+                }
+    }
+}
+
+LateReverbGenerator::DecayProfile LateReverbGenerator::analyse(const std::vector<float>& ir, std::size_t tailStart, double sampleRate)
+{
+    DecayProfile profile;
+    profile.sampleRate = sampleRate;
+    profile.fadeLength = std::min(tailStart, (std::size_t)(buildUpSeconds * sampleRate));
+    profile.onset      = tailStart;
+
+    const std::size_t window = (std::size_t)(calibrationSeconds * sampleRate);
+    if (tailStart + window > ir.size() || window == 0)
+        return profile;
+
+    // Broadband estimate fills in for bands whose decay can't be fitted
+    float broadband = estimateRT60(ir, sampleRate);
+    if (broadband <= 0.0f)
+        broadband = fallbackRT60;
+
+    for (const float centre : octaveCentres)
+    {
+        if (centre >= 0.45 * sampleRate)
+            break;
+
+        std::vector<float> band(ir);
+        bandPass(band, centre, sampleRate);
+        const float rt60 = estimateRT60(band, sampleRate);
+
+        profile.bandFrequencies.push_back(centre);
+        profile.bandRT60.push_back(rt60 > 0.0f ? rt60 : broadband);
+    }
+
+    // Render the uncalibrated tail and match its level to the IR just past
+    // tailStart, where the network has had the whole build-up to densify
+    profile.outputGain = 1.0f;
+    LateReverbGenerator probe(profile);
+
+    std::vector<float> response(tailStart + window, 0.0f);
+    std::vector<float> impulse(response.size(), 0.0f);
+    impulse[0] = 1.0f;
+    probe.processBlock(impulse.data(), response.data(), response.size());
+
+    double irEnergy = 0.0, tailEnergy = 0.0;
+    for (std::size_t n = tailStart; n < tailStart + window; n++)
+    {
+        irEnergy   += (double)ir[n] * ir[n];
+        tailEnergy += (double)response[n] * response[n];
+    }
+
+    profile.outputGain = (irEnergy > 0.0 && tailEnergy > 0.0)
+                             ? (float)std::sqrt(irEnergy / tailEnergy)
+                             : 0.0f;
+    if (!profile.isValid())
+        return profile;
+
+    // Energy-complementary crossfade: through the build-up the head keeps
+    // whatever share of the IR's energy the network doesn't supply yet, so
+    // the sum follows the IR's envelope while the network thickens
+    const std::size_t fadeStart = tailStart - profile.fadeLength;
+    const std::size_t span      = std::max<std::size_t>(1, (std::size_t)(envelopeSeconds * sampleRate));
+    const auto irEnvelope   = energyEnvelope(ir, fadeStart, tailStart, span);
+    const auto tailEnvelope = energyEnvelope(response, fadeStart, tailStart, span);
+    const double tailScale  = (double)profile.outputGain * profile.outputGain;
+
+    profile.headFade.resize(profile.fadeLength);
+    for (std::size_t i = 0; i < profile.fadeLength; i++)
+    {
+        const double share = irEnvelope[i] > 0.0 ? tailScale * tailEnvelope[i] / irEnvelope[i] : 1.0;
+        profile.headFade[i] = (float)std::sqrt(std::clamp(1.0 - share, 0.0, 1.0));
+    }
+
+    return profile;
+}
+
+std::vector<float> LateReverbGenerator::extractHead(const std::vector<float>& ir, const DecayProfile& profile)
+{
+    std::vector<float> head(ir.begin(), ir.begin() + (std::ptrdiff_t)std::min(profile.onset, ir.size()));
+
+    // Crossfade into the generated tail
+    const std::size_t fade = std::min(profile.headFade.size(), head.size());
+    for (std::size_t i = 0; i < fade; i++)
+        head[head.size() - fade + i] *= profile.headFade[profile.headFade.size() - fade + i];
+
+    return head;
+}
+
+LateReverbGenerator::LateReverbGenerator(const DecayProfile& profile)
+    : outputGain(profile.outputGain), longestLine(0), quietSamples(0), idle(true)
+{
+    if (profile.bandRT60.empty()) throw std::invalid_argument("Decay profile has no bands");
+
+    const double sr = profile.sampleRate;
+
+    // Jot-style absorption: the broadband gain sets the low-frequency decay,
+    // a one-pole low-pass bends it down to the highest band's decay
+    double rt60Low = 0.0;
+    std::size_t numLow = 0;
+    for (std::size_t b = 0; b < profile.bandRT60.size(); b++)
+        if (profile.bandFrequencies[b] <= lowBandLimit)
+        {
+            rt60Low += profile.bandRT60[b];
+            numLow++;
+        }
+    rt60Low = numLow > 0 ? rt60Low / (double)numLow : profile.bandRT60.front();
+
+    const double rt60High = std::min<double>(profile.bandRT60.back(), rt60Low);
+    const double wHigh    = 2.0 * pi * profile.bandFrequencies.back() / sr;
+
+    std::size_t minLength = 0;
+    for (std::size_t i = 0; i < numLines; i++)
+    {
+        auto& line = lines[i];
+        const std::size_t length = std::max<std::size_t>(1, (std::size_t)(lineLengthsMs[i] * 0.001 * sr));
+        line.buffer.assign(length, 0.0f);
+        minLength = (i == 0) ? length : std::min(minLength, length);
+        longestLine = std::max(longestLine, length);
+
+        const double gLow  = decayGain((double)length, rt60Low, sr);
+        const double gHigh = decayGain((double)length, rt60High, sr);
+        line.gain = (float)gLow;
+
+        // Solve |(1 - p) / (1 - p e^{-jw})| = gHigh / gLow for the pole p
+        const double r2 = (gHigh / gLow) * (gHigh / gLow);
+        if (r2 < 0.9999)
+        {
+            const double a = 1.0 - r2;
+            const double b = -2.0 * (1.0 - r2 * std::cos(wHigh));
+            const double p = (-b - std::sqrt(std::max(0.0, b * b - 4.0 * a * a))) / (2.0 * a);
+            line.pole = (float)std::clamp(p, 0.0, 0.99);
+        }
+    }
+
+    for (std::size_t i = 0; i < diffusers.size(); i++)
+    {
+        auto& diffuser = diffusers[i];
+        diffuser.buffer.assign(std::max<std::size_t>(1, (std::size_t)(diffuserSettings[i].first * 0.001 * sr)), 0.0f);
+        diffuser.gain = diffuserSettings[i].second;
+    }
+
+    // First echo lands at the start of the build-up
+    const std::size_t firstEcho = profile.onset - profile.fadeLength;
+    const std::size_t delay = firstEcho > minLength ? firstEcho - minLength : 0;
+    preDelay = std::make_unique<SparseTapConvolver>(std::vector<SparseTapConvolver::Tap>{ { delay, 1.0f } });
+
+    // Output sums numLines line outputs, each at most the line contents
+    idleThreshold = outputGain > 0.0f ? silenceLevel / (outputGain * (float)numLines) : 0.0f;
+}
+
+void LateReverbGenerator::reset()
+{
+    for (auto& line : lines)
+    {
+        std::fill(line.buffer.begin(), line.buffer.end(), 0.0f);
+        line.writeIndex = 0;
+        line.state = 0.0f;
+    }
+    for (auto& diffuser : diffusers)
+    {
+        std::fill(diffuser.buffer.begin(), diffuser.buffer.end(), 0.0f);
+        diffuser.index = 0;
+    }
+    preDelay->reset();
+    quietSamples = 0;
+    idle = true;
+}
+
+float LateReverbGenerator::processSample(float x)
+{
+    // Smear the input through the diffusers before it reaches the lines
+    float in = preDelay->processSample(x);
+    float peak = 0.0f;
+    for (auto& diffuser : diffusers)
+    {
+        const float delayed = diffuser.buffer[diffuser.index];
+        const float v = in + diffuser.gain * delayed;
+        diffuser.buffer[diffuser.index] = v;
+        diffuser.index = (diffuser.index + 1) % diffuser.buffer.size();
+        peak = std::max(peak, std::abs(v));
+        in = delayed - diffuser.gain * v;
+    }
+
+    // Read each line and apply its frequency-dependent decay
+    std::array<float, numLines> taps;
+    float sum = 0.0f;
+    for (std::size_t i = 0; i < numLines; i++)
+    {
+        auto& line = lines[i];
+        const float out = line.buffer[line.writeIndex];
+        line.state = line.gain * (1.0f - line.pole) * out + line.pole * line.state;
+        taps[i] = line.state;
+        sum += (i & 1) ? -taps[i] : taps[i];
+    }
+
+    // Lossless Hadamard feedback, normalised by 1/sqrt(8)
+    hadamard(taps);
+    constexpr float norm = 0.35355339059327373f;
+
+    for (std::size_t i = 0; i < numLines; i++)
+    {
+        auto& line = lines[i];
+        const float v = in * inputSigns[i] + taps[i] * norm;
+        line.buffer[line.writeIndex] = v;
+        line.writeIndex = (line.writeIndex + 1) % line.buffer.size();
+        peak = std::max(peak, std::abs(v));
+    }
+    quietSamples = (peak < idleThreshold) ? quietSamples + 1 : 0;
+
+    return sum * outputGain;
+}
+
+void LateReverbGenerator::processBlock(const float* in, float* out, std::size_t numSamples)
+{
+    if (idle && std::all_of(in, in + numSamples, [](float s) { return s == 0.0f; }))
+    {
+        std::fill(out, out + numSamples, 0.0f);
+        return;
+    }
+
+    idle = false;
+    for (std::size_t n = 0; n < numSamples; n++)
+        out[n] = processSample(in[n]);
+
+    // Every line has been overwritten with inaudible values and nothing is
+    // queued in the pre-delay: flush the residue and stop running the network
+    if (quietSamples >= longestLine && preDelay->isIdle())
+        reset();
+}
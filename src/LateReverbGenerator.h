@@ -0,0 +1,75 @@
+#pragma once
+
+#include "SparseTapConvolver.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+
+class LateReverbGenerator {
+public:
+    // Decay of the measured IR, estimated once at load and shared by every
+    // channel. onset is where the generated tail takes over from the head;
+    // the network starts fadeLength earlier, and headFade is the gain on
+    // the head over that span.
+    struct DecayProfile
+    {
+        std::vector<float> bandFrequencies;
+        std::vector<float> bandRT60;
+        double             sampleRate = 44100.0;
+        std::size_t        onset      = 0;
+        std::size_t        fadeLength = 0;
+        float              outputGain = 0.0f;
+        std::vector<float> headFade;
+
+        bool isValid() const { return outputGain > 0.0f; }
+    };
+
+    // Estimate per-band RT60 from the Schroeder decay of the IR and calibrate
+    // the tail level against the IR just after tailStart. Returns an invalid
+    // profile if the IR has nothing worth synthesizing past tailStart.
+    static DecayProfile analyse(const std::vector<float>& ir, std::size_t tailStart, double sampleRate);
+
+    // The measured part of the IR that is still convolved exactly, faded out
+    // against the network's build-up
+    static std::vector<float> extractHead(const std::vector<float>& ir, const DecayProfile& profile);
+
+    LateReverbGenerator(const DecayProfile& profile);
+    void reset();
+    float processSample(float x);
+    void processBlock(const float* in, float* out, std::size_t numSamples);
+
+    // True once the network has rung out and been flushed to zero
+    bool isIdle() const { return idle; }
+
+private:
+    static constexpr std::size_t numLines = 8;
+
+    struct DelayLine
+    {
+        std::vector<float> buffer;
+        std::size_t        writeIndex = 0;
+        float              gain       = 1.0f;   // broadband decay per pass
+        float              pole       = 0.0f;   // one-pole HF absorption
+        float              state      = 0.0f;
+    };
+
+    struct Diffuser
+    {
+        std::vector<float> buffer;
+        std::size_t        index = 0;
+        float              gain  = 0.0f;
+    };
+
+    std::array<DelayLine, numLines>     lines;
+    std::array<Diffuser, 4>             diffusers;
+    std::unique_ptr<SparseTapConvolver> preDelay;
+    float                               outputGain;
+
+    // Line contents below this are inaudible at the output
+    float                               idleThreshold;
+    std::size_t                         longestLine;
+    std::size_t                         quietSamples;
+    bool                                idle;
+};
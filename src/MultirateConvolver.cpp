@@ -0,0 +1,180 @@
+#include "MultirateConvolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+MultirateConvolver::MultirateConvolver(const std::vector<float> &h, int factor,
+                                       int blockSize)
+    : M(factor), L(24 * factor + 1), lowpass((size_t)L) {
+  jassert(M == 2 || M == 4);
+  jassert(!h.empty() && blockSize > 0);
+
+  designLowpass();
+
+  // Band-limit the IR (zero phase) and keep every M-th sample. Scaling by M
+  // keeps the low-rate convolution at the same gain as the full-rate one.
+  const int centre = (L - 1) / 2;
+  const int N = (int)h.size();
+  const int lowN = (N + M - 1) / M;
+  std::vector<float> hLow((size_t)lowN, 0.0f);
+  for (int k = 0; k < lowN; ++k) {
+    double acc = 0.0;
+    for (int i = 0; i < L; ++i) {
+      const int n = k * M + centre - i;
+      if (n >= 0 && n < N)
+        acc += (double)lowpass[(size_t)i] * h[(size_t)n];
+    }
+    hLow[(size_t)k] = (float)(acc * M);
+  }
+
+  // A host block yields at most ceil(blockSize / M) decimated samples
+  const int lowBlock = (blockSize + M - 1) / M;
+  convolver = std::make_unique<FreqDomainConvolver>(
+      hLow, getLowRateFFTOrder(N, M, blockSize), lowBlock);
+
+  allocateBuffers(lowBlock);
+}
+
+MultirateConvolver::MultirateConvolver(
+    int irLength, const FreqDomainConvolver::Spectrum &lowRateSpectrum,
+    int factor, int blockSize)
+    : M(factor), L(24 * factor + 1), lowpass((size_t)L) {
+  jassert(M == 2 || M == 4);
+  jassert(irLength > 0 && blockSize > 0);
+
+  designLowpass();
+
+  const int lowN = (irLength + M - 1) / M;
+  const int lowBlock = (blockSize + M - 1) / M;
+  convolver = std::make_unique<FreqDomainConvolver>(
+      lowN, lowRateSpectrum, getLowRateFFTOrder(irLength, M, blockSize),
+      lowBlock);
+
+  allocateBuffers(lowBlock);
+}
+
+int MultirateConvolver::getLowRateFFTOrder(int irLength, int factor,
+                                           int blockSize) {
+  const int lowN = (irLength + factor - 1) / factor;
+  const int lowBlock = (blockSize + factor - 1) / factor;
+  int order = 1;
+  while ((1 << order) < lowBlock + lowN - 1)
+    ++order;
+  return order;
+}
+
+void MultirateConvolver::designLowpass() {
+  // Blackman-windowed sinc, cut off at 90% of the decimated Nyquist
+  const double pi = juce::MathConstants<double>::pi;
+  const double fc = 0.45 / (double)M; // cycles per full-rate sample
+  const int centre = (L - 1) / 2;
+  double sum = 0.0;
+  for (int n = 0; n < L; ++n) {
+    const double t = (double)(n - centre);
+    const double sinc =
+        (n == centre) ? 2.0 * fc : std::sin(2.0 * pi * fc * t) / (pi * t);
+    const double w = 0.42 - 0.5 * std::cos(2.0 * pi * n / (L - 1)) +
+                     0.08 * std::cos(4.0 * pi * n / (L - 1));
+    lowpass[(size_t)n] = (float)(sinc * w);
+    sum += sinc * w;
+  }
+  for (auto &c : lowpass)
+    c = (float)(c / sum);
+}
+
+void MultirateConvolver::allocateBuffers(int lowBlock) {
+  inHistory.assign((size_t)L, 0.0f);
+  outHistory.assign((size_t)((L + M - 1) / M), 0.0f);
+  lowIn.assign((size_t)lowBlock, 0.0f);
+  lowTimes.assign((size_t)lowBlock, 0);
+
+  reset();
+}
+
+void MultirateConvolver::reset() {
+  std::fill(inHistory.begin(), inHistory.end(), 0.0f);
+  std::fill(outHistory.begin(), outHistory.end(), 0.0f);
+  inIndex = outIndex = 0;
+  inPhase = outPhase = 0;
+  silentIn = L;
+  silentOut = (int)outHistory.size();
+  convolver->reset();
+}
+
+bool MultirateConvolver::isIdle() const {
+  return silentIn >= L && silentOut >= (int)outHistory.size() &&
+         convolver->isIdle();
+}
+
+void MultirateConvolver::processBlock(const float *x, float *y,
+                                      int numSamples) {
+  // lowIn holds the decimated samples of at most lowIn.size() * M input
+  // samples, so longer blocks are split rather than overrunning it
+  const int maxChunk = (int)lowIn.size() * M;
+  for (int offset = 0; offset < numSamples; offset += maxChunk)
+    processChunk(x + offset, y + offset,
+                 std::min(maxChunk, numSamples - offset));
+}
+
+void MultirateConvolver::processChunk(const float *x, float *y,
+                                      int numSamples) {
+  if (isIdle() &&
+      std::all_of(x, x + numSamples, [](float s) { return s == 0.0f; })) {
+    std::fill(y, y + numSamples, 0.0f);
+    return;
+  }
+
+  // 1. Decimate: only evaluate the anti-alias filter on kept samples
+  int count = 0;
+  for (int n = 0; n < numSamples; ++n) {
+    inHistory[(size_t)inIndex] = x[n];
+    silentIn = (x[n] == 0.0f) ? silentIn + 1 : 0;
+
+    if (++inPhase == M) {
+      inPhase = 0;
+
+      float acc = 0.0f;
+      int idx = inIndex;
+      for (int i = 0; i < L; ++i) {
+        acc += lowpass[(size_t)i] * inHistory[(size_t)idx];
+        idx = (idx == 0) ? L - 1 : idx - 1;
+      }
+
+      lowIn[(size_t)count] = acc;
+      lowTimes[(size_t)count] = n;
+      ++count;
+    }
+
+    inIndex = (inIndex + 1) % L;
+  }
+
+  // 2. Convolve at the low rate
+  std::vector<float> lowOut;
+  if (count > 0)
+    lowOut = convolver->processBlock(lowIn.data(), count);
+
+  // 3. Interpolate: in the zero-stuffed signal only every M-th filter tap
+  // lines up with a decimated sample, so read just those
+  const int H = (int)outHistory.size();
+  int next = 0;
+  for (int n = 0; n < numSamples; ++n) {
+    if (next < count && lowTimes[(size_t)next] == n) {
+      const float v = lowOut[(size_t)next++];
+      outIndex = (outIndex + 1) % H;
+      outHistory[(size_t)outIndex] = v;
+      silentOut = (v == 0.0f) ? silentOut + 1 : 0;
+      outPhase = 0;
+    } else {
+      ++outPhase;
+    }
+
+    float acc = 0.0f;
+    int idx = outIndex;
+    for (int tap = outPhase; tap < L; tap += M) {
+      acc += lowpass[(size_t)tap] * outHistory[(size_t)idx];
+      idx = (idx == 0) ? H - 1 : idx - 1;
+    }
+
+    y[n] = acc * (float)M;
+  }
+}
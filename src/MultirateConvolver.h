@@ -0,0 +1,66 @@
+#pragma once
+#include "FreqDomainConvolver.h"
+#include <memory>
+#include <vector>
+
+// Convolves at 1/factor of the host rate: polyphase FIR decimation, a
+// FreqDomainConvolver on the decimated IR, then polyphase interpolation back
+// up. The IR is low-passed to the reduced band first, so this is meant for
+// late reverb where the high end has already decayed.
+class MultirateConvolver
+{
+public:
+    // factor must be 2 or 4; blockSize is the full-rate host block size
+    MultirateConvolver(const std::vector<float>& h, int factor, int blockSize);
+
+    // Rebuild from a spectrum saved with getLowRateSpectrum(); irLength is the
+    // full-rate length of the original IR
+    MultirateConvolver(int irLength, const FreqDomainConvolver::Spectrum& lowRateSpectrum,
+                       int factor, int blockSize);
+
+    void reset();
+
+    // Process one full-rate block of any length
+    void processBlock(const float* x, float* y, int numSamples);
+
+    // Full-rate delay added by the resampling filters. Feed the input this
+    // many samples early to keep the IR aligned.
+    int getLatency() const { return L - 1; }
+    int getFactor()  const { return M; }
+
+    const FreqDomainConvolver::Spectrum& getLowRateSpectrum() const { return convolver->getIRSpectrum(); }
+
+    // FFT order of the low-rate engine for a full-rate IR length
+    static int getLowRateFFTOrder(int irLength, int factor, int blockSize);
+
+    bool isIdle() const;
+
+private:
+    void designLowpass();
+    void allocateBuffers(int lowBlock);
+
+    // At most blockSize samples, so the decimated count fits in lowIn
+    void processChunk(const float* x, float* y, int numSamples);
+
+    const int M;           // decimation factor
+    const int L;           // resampling filter length
+
+    std::vector<float> lowpass;          // shared anti-alias / anti-image FIR
+    std::unique_ptr<FreqDomainConvolver> convolver;
+
+    // Full-rate input history for the decimator (circular, L samples)
+    std::vector<float> inHistory;
+    int inIndex = 0;
+    int inPhase = 0;                     // full-rate samples since last decimated output
+    int silentIn = 0;
+
+    // Decimated output history for the interpolator (circular)
+    std::vector<float> outHistory;
+    int outIndex = 0;
+    int outPhase = 0;                    // full-rate samples since last decimated input
+    int silentOut = 0;
+
+    // Low-rate block buffer and the full-rate sample index each entry lands on
+    std::vector<float> lowIn;
+    std::vector<int> lowTimes;
+};
@@ -28,7 +28,9 @@ void SpectralConvolverAudioProcessorEditor::paint (juce::Graphics& g)
 
     g.setColour (juce::Colours::white);
     g.setFont (juce::FontOptions (15.0f));
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+    const auto restoreError = audioProcessor.getIRRestoreError();
+    g.drawFittedText (restoreError.isNotEmpty() ? restoreError : juce::String ("Hello World!"),
+                      getLocalBounds().reduced (10), juce::Justification::centred, 3);
 }
 
 void SpectralConvolverAudioProcessorEditor::resized()
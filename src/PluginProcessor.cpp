@@ -19,11 +19,6 @@ SpectralConvolverAudioProcessor::SpectralConvolverAudioProcessor()
 
   juce::Logger::writeToLog("SPECTRAL CONVOLVER LOADED");
 
-  // Create a file as proof the code ran
-  juce::File("/tmp/plugin_loaded.txt")
-      .replaceWithText("Plugin loaded at " +
-                       juce::Time::getCurrentTime().toString(true, true));
-
   //  const int defaultIRLength = 4410; // 100ms at 44.1kHz
   //  std::vector<float> defaultIR(defaultIRLength);
   //
@@ -65,16 +60,14 @@ SpectralConvolverAudioProcessor::SpectralConvolverAudioProcessor()
   //
   //    loadImpulseResponse(defaultIR);
 
-  // Load IR from hardcoded path
-  juce::File irFile(
-      "/Users/izanagi/repos/spectral-convolution-plugin/assets/IR copy.wav");
-
-  if (!loadImpulseResponseFromFile(irFile)) {
-    DBG("Failed to load IR from: " + irFile.getFullPathName());
-  }
+  // No IR until the host restores state or one is loaded from file; both
+  // go through loadImpulseResponse, so there is no file I/O here
 }
 
-SpectralConvolverAudioProcessor::~SpectralConvolverAudioProcessor() {}
+SpectralConvolverAudioProcessor::~SpectralConvolverAudioProcessor() {
+  // Don't lose spectra that were computed but not yet written to the cache
+  handleUpdateNowIfNeeded();
+}
 
 const juce::String SpectralConvolverAudioProcessor::getName() const {
   return JucePlugin_Name;
@@ -143,54 +136,269 @@ int SpectralConvolverAudioProcessor::calculateFFTOrder(int irLen,
     ++order;
 
   // Clamp to reasonable range (64 to 16384)
-  order = std::max(6, std::min(14, order));
+  order = std::max(6, std::min(maxFFTOrder, order));
 
   return order;
 }
 
 void SpectralConvolverAudioProcessor::rebuildConvolvers() {
-  const juce::SpinLock::ScopedLockType lock(irLock);
+  // Runs from prepareToPlay or on the thread that changed the IR or
+  // settings, never from processBlock; concurrent rebuilds are serialised
+  const juce::ScopedLock rebuildGuard(rebuildLock);
+
+  // Work from one consistent snapshot so a concurrent setter can't mix two
+  // configurations into one set of engines
+  std::vector<float> ir;
+  juce::String irHash;
+  {
+    const juce::SpinLock::ScopedLockType lock(irLock);
+    ir = currentIR;
+    irHash = currentIRHash;
+  }
+  const bool hybrid = hybridTail.load();
+  const auto tier = qualityTier.load();
 
-  convolvers.clear();
+  // In hybrid mode everything past the head (at most 300 ms) is synthesized,
+  // so only the head goes on to the convolution engines
+  LateReverbGenerator::DecayProfile tailProfile;
+  if (hybrid && !ir.empty())
+    tailProfile = getDecayProfile(ir, irHash);
 
-  if (currentIR.empty())
-    return;
+  auto newEngines = ir.empty()
+                        ? std::vector<ChannelEngine>()
+                        : buildEngines(ir, irHash, tailProfile, tier);
+  const bool loaded = !newEngines.empty();
 
-  // Calculate optimal FFT order for current settings
-  fftOrder = calculateFFTOrder(irLength, currentBlockSize);
+  // The audio thread only ever sees a finished set of engines
+  {
+    const juce::SpinLock::ScopedLockType lock(irLock);
+    engines.swap(newEngines);
+  }
+  irLoaded.store(loaded);
+
+  // newEngines now holds the old set, freed here rather than under the lock
+}
+
+std::vector<SpectralConvolverAudioProcessor::ChannelEngine>
+SpectralConvolverAudioProcessor::buildEngines(
+    const std::vector<float> &ir, const juce::String &irHash,
+    const LateReverbGenerator::DecayProfile &tailProfile, QualityTier tier) {
+  std::vector<ChannelEngine> result;
+
+  const auto convolvedIR = tailProfile.isValid()
+                               ? LateReverbGenerator::extractHead(ir, tailProfile)
+                               : ir;
+
+  // On reduced quality tiers only the diffuse part inside the early window
+  // stays at the host rate; the rest is convolved decimated
+  const auto maxEarlySamples = static_cast<std::size_t>(currentSampleRate * 0.08);
+  const int factor = getDecimationFactor(tier);
+
+  // FFT order of the full-rate engine for a diffuse part of this length
+  // starting this far into the IR
+  const auto fullRateOrder = [&](std::size_t length, std::size_t offset) {
+    if (factor > 1)
+      length = std::min(length,
+                        std::max(maxEarlySamples, offset) - offset);
+    return calculateFFTOrder(static_cast<int>(length), currentBlockSize);
+  };
+
+  // Pull discrete early reflections out of the first 80 ms so the FFT engine
+  // only has to cover the diffuse remainder. That only pays off if the
+  // remainder needs a smaller FFT; with a noise floor between reflections it
+  // starts almost at sample 0, and the taps would just be extra work.
+  auto split = SparseTapConvolver::splitIR(convolvedIR, maxEarlySamples);
+  if (!split.taps.empty() &&
+      fullRateOrder(split.diffuse.size(), split.diffuseOffset) >=
+          fullRateOrder(convolvedIR.size(), 0)) {
+    split = {};
+    split.diffuse = convolvedIR;
+  }
+  std::vector<float> fullRateIR = split.diffuse;
+  std::vector<float> decimatedIR;
+  std::size_t decimatedOffset = 0;
+
+  if (factor > 1 && !split.diffuse.empty()) {
+    const auto lateStart = std::max(maxEarlySamples, split.diffuseOffset);
+    const auto cut = lateStart - split.diffuseOffset;
+
+    if (cut < split.diffuse.size()) {
+      decimatedIR.assign(split.diffuse.begin() +
+                             static_cast<std::ptrdiff_t>(cut),
+                         split.diffuse.end());
+      fullRateIR.resize(cut);
+      decimatedOffset = lateStart;
+    }
+  }
+
+  // FreqDomainConvolver needs some energy in its IR
+  const auto hasSignal = [](const std::vector<float> &v) {
+    return std::any_of(v.begin(), v.end(), [](float x) { return x != 0.0f; });
+  };
+  if (!hasSignal(fullRateIR))
+    fullRateIR.clear();
+  if (!hasSignal(decimatedIR))
+    decimatedIR.clear();
 
-  // One convolver per channel
+  // Calculate optimal FFT order for current settings
+  int fftOrder = 0;
+  if (!fullRateIR.empty())
+    fftOrder = calculateFFTOrder(static_cast<int>(fullRateIR.size()),
+                                 currentBlockSize);
+
+  // IR spectra are identical for every channel: take them from the disk
+  // cache if this IR was prepared the same way before, otherwise compute
+  // them once on the first channel and queue them for the cache
+  const int decimatedOrder =
+      decimatedIR.empty()
+          ? 0
+          : MultirateConvolver::getLowRateFFTOrder(
+                static_cast<int>(decimatedIR.size()), factor, currentBlockSize);
+
+  const bool hybrid = tailProfile.isValid();
+  const auto fullRateKey =
+      makeSpectrumKey(irHash, "fullRate", fftOrder, hybrid, tier);
+  const auto decimatedKey =
+      makeSpectrumKey(irHash, "decimated", decimatedOrder, hybrid, tier);
+
+  FreqDomainConvolver::Spectrum fullRateSpectrum, decimatedSpectrum;
+  if (!fullRateIR.empty() && fullRateKey.isNotEmpty())
+    irCache.loadSpectrum(fullRateKey, 1 << fftOrder, fullRateSpectrum);
+  if (!decimatedIR.empty() && decimatedKey.isNotEmpty())
+    irCache.loadSpectrum(decimatedKey, 1 << decimatedOrder, decimatedSpectrum);
+
+  // One engine per channel
   const int numChannels =
       std::max(getTotalNumInputChannels(), getTotalNumOutputChannels());
 
   for (int ch = 0; ch < numChannels; ++ch) {
-    convolvers.push_back(std::make_unique<FreqDomainConvolver>(
-        currentIR, fftOrder, currentBlockSize));
+    ChannelEngine engine;
+
+    if (!split.taps.empty())
+      engine.earlyTaps = std::make_unique<SparseTapConvolver>(split.taps);
+
+    if (!fullRateIR.empty()) {
+      if (split.diffuseOffset > 0)
+        engine.diffuseDelay = std::make_unique<SparseTapConvolver>(
+            std::vector<SparseTapConvolver::Tap>{{split.diffuseOffset, 1.0f}});
+
+      if (fullRateSpectrum.empty()) {
+        engine.diffuse = std::make_unique<FreqDomainConvolver>(
+            fullRateIR, fftOrder, currentBlockSize);
+        fullRateSpectrum = engine.diffuse->getIRSpectrum();
+        queueSpectrumForCache(fullRateKey, fullRateSpectrum);
+      } else {
+        engine.diffuse = std::make_unique<FreqDomainConvolver>(
+            static_cast<int>(fullRateIR.size()), fullRateSpectrum, fftOrder,
+            currentBlockSize);
+      }
+    }
+
+    if (!decimatedIR.empty()) {
+      if (decimatedSpectrum.empty()) {
+        engine.decimated = std::make_unique<MultirateConvolver>(
+            decimatedIR, factor, currentBlockSize);
+        decimatedSpectrum = engine.decimated->getLowRateSpectrum();
+        queueSpectrumForCache(decimatedKey, decimatedSpectrum);
+      } else {
+        engine.decimated = std::make_unique<MultirateConvolver>(
+            static_cast<int>(decimatedIR.size()), decimatedSpectrum, factor,
+            currentBlockSize);
+      }
+
+      // The resampling filters delay the output, so start that much earlier.
+      // The early window is always far longer than the filter latency.
+      const auto latency =
+          static_cast<std::size_t>(engine.decimated->getLatency());
+      jassert(decimatedOffset >= latency);
+      engine.decimatedDelay = std::make_unique<SparseTapConvolver>(
+          std::vector<SparseTapConvolver::Tap>{
+              {decimatedOffset - std::min(latency, decimatedOffset), 1.0f}});
+    }
+
+    if (tailProfile.isValid())
+      engine.lateTail = std::make_unique<LateReverbGenerator>(tailProfile);
+
+    result.push_back(std::move(engine));
   }
 
-  irLoaded.store(true);
-  irPendingRebuild.store(false);
+  DBG("Convolvers rebuilt: " << numChannels << " channels, "
+                             << static_cast<int>(split.taps.size())
+                             << " early taps, diffuse offset "
+                             << static_cast<int>(split.diffuseOffset)
+                             << ", FFT order " << fftOrder << " (size "
+                             << (1 << fftOrder) << "), IR length "
+                             << static_cast<int>(ir.size())
+                             << ", decimated tail "
+                             << static_cast<int>(decimatedIR.size()) << " @ 1/"
+                             << factor << ", synthesized tail "
+                             << (tailProfile.isValid() ? "on" : "off"));
+
+  return result;
+}
+
+LateReverbGenerator::DecayProfile
+SpectralConvolverAudioProcessor::getDecayProfile(const std::vector<float> &ir,
+                                                 const juce::String &irHash) {
+  // The head stays with the full-rate FFT engine, which tops out at
+  // 2^maxFFTOrder points and must hold a block alongside it, so at high
+  // rates or with large blocks the generated tail takes over before 300 ms
+  const auto maxHead = static_cast<std::size_t>(
+      std::max(1, (1 << maxFFTOrder) - currentBlockSize + 1));
+  const auto tailStart = std::min(
+      static_cast<std::size_t>(currentSampleRate * 0.3), maxHead);
+
+  // The analysis only depends on the IR, sample rate and onset, so switching
+  // tiers reuses the last result instead of filtering the IR again
+  const auto key = irHash + "|" + juce::String(currentSampleRate) + "|" +
+                   juce::String(static_cast<int>(tailStart));
+  if (key != decayProfileKey || irHash.isEmpty()) {
+    decayProfile =
+        LateReverbGenerator::analyse(ir, tailStart, currentSampleRate);
+    decayProfileKey = key;
+  }
 
-  DBG("Convolvers rebuilt: " << numChannels << " channels, FFT order "
-                             << fftOrder << " (size " << (1 << fftOrder)
-                             << "), IR length " << irLength);
+  return decayProfile;
 }
 
 void SpectralConvolverAudioProcessor::prepareToPlay(double sampleRate,
                                                     int samplesPerBlock) {
+  // Held across the rebuild so a rebuild from the message thread can't pick
+  // up a half-updated rate and block size
+  const juce::ScopedLock rebuildGuard(rebuildLock);
+
   currentSampleRate = sampleRate;
   currentBlockSize = samplesPerBlock;
 
+  // The audio thread isn't running yet, so the scratch buffers are sized
+  // here and processBlock doesn't allocate for blocks up to this size
+  wetScratch.assign(static_cast<size_t>(samplesPerBlock), 0.0f);
+  tapScratch.assign(static_cast<size_t>(samplesPerBlock), 0.0f);
+  delayScratch.assign(static_cast<size_t>(samplesPerBlock), 0.0f);
+  lateScratch.assign(static_cast<size_t>(samplesPerBlock), 0.0f);
+  silenceScratch.assign(static_cast<size_t>(samplesPerBlock), 0.0f);
+
   // Rebuild convolvers with new settings
   rebuildConvolvers();
+  isPrepared.store(true);
 }
 
 void SpectralConvolverAudioProcessor::releaseResources() {
   // Reset convolvers when playback stops
   const juce::SpinLock::ScopedLockType lock(irLock);
-  for (auto &conv : convolvers) {
-    if (conv)
-      conv->reset();
+  for (auto &engine : engines) {
+    if (engine.earlyTaps)
+      engine.earlyTaps->reset();
+    if (engine.diffuseDelay)
+      engine.diffuseDelay->reset();
+    if (engine.diffuse)
+      engine.diffuse->reset();
+    if (engine.decimatedDelay)
+      engine.decimatedDelay->reset();
+    if (engine.decimated)
+      engine.decimated->reset();
+    if (engine.lateTail)
+      engine.lateTail->reset();
   }
 }
 
@@ -223,7 +431,7 @@ void SpectralConvolverAudioProcessor::processBlock(
   if (firstCall) {
     firstCall = false;
     DBG("========== PROCESSBLOCK FIRST CALL ==========");
-    DBG("convolvers.size(): " + juce::String(convolvers.size()));
+    DBG("engines.size(): " + juce::String(engines.size()));
     DBG("currentIR.size(): " + juce::String(currentIR.size()));
     DBG("buffer samples: " + juce::String(buffer.getNumSamples()));
     DBG("=============================================");
@@ -241,23 +449,19 @@ void SpectralConvolverAudioProcessor::processBlock(
   for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
     buffer.clear(i, 0, numSamples);
 
-  // Check if IR needs rebuilding
-  if (irPendingRebuild.load())
-    rebuildConvolvers();
-
-  // If no IR loaded or no convolvers, pass through dry signal
-  if (!irLoaded.load() || convolvers.empty())
+  // If no IR loaded, pass through dry signal
+  if (!irLoaded.load())
     return;
 
   // Try to acquire lock
   // If IR being swapped, pass through
   const juce::SpinLock::ScopedTryLockType lock(irLock);
-  if (!lock.isLocked())
+  if (!lock.isLocked() || engines.empty())
     return;
 
-  // Process each channel through respective convolver
+  // Process each channel through respective engine
   for (int channel = 0; channel < totalNumInputChannels; ++channel) {
-    if (channel >= static_cast<int>(convolvers.size()) || !convolvers[channel])
+    if (channel >= static_cast<int>(engines.size()))
       continue;
 
     auto *channelData = buffer.getWritePointer(channel);
@@ -268,8 +472,21 @@ void SpectralConvolverAudioProcessor::processBlock(
       drySignal.assign(channelData, channelData + numSamples);
     }
 
-    // Process through convolver
-    auto wetSignal = convolvers[channel]->processBlock(channelData, numSamples);
+    // Inputs below the silence threshold are treated as digital silence so
+    // the engines can take their zero-input fast paths
+    auto &engine = engines[static_cast<size_t>(channel)];
+    const bool inputSilent =
+        buffer.getMagnitude(channel, 0, numSamples) <= silenceThreshold;
+
+    // Process through early taps + diffuse convolver, or skip the engine
+    // entirely once a silent channel's tail has fully decayed
+    auto &wetSignal = wetScratch;
+    if (inputSilent && isEngineIdle(engine)) {
+      wetSignal.resize(static_cast<size_t>(numSamples));
+      std::fill(wetSignal.begin(), wetSignal.end(), 0.0f);
+    } else {
+      processChannel(engine, channelData, inputSilent, wetSignal, numSamples);
+    }
 
     static int debugCounter = 0;
     if (++debugCounter % 200 == 0) // Log every few seconds
@@ -335,25 +552,166 @@ void SpectralConvolverAudioProcessor::processBlock(
   }
 }
 
+void SpectralConvolverAudioProcessor::processChannel(ChannelEngine &engine,
+                                                     const float *input,
+                                                     bool inputSilent,
+                                                     std::vector<float> &wet,
+                                                     int numSamples) {
+  // Within the capacity reserved at prepare time this doesn't allocate; a
+  // host may still send a larger block than it announced, so grow if needed
+  wet.resize(static_cast<size_t>(numSamples));
+  std::fill(wet.begin(), wet.end(), 0.0f);
+
+  // The engines and scratch buffers are sized for the prepared block size,
+  // so larger host blocks are run through in pieces of at most that size
+  const int maxChunk = static_cast<int>(tapScratch.size());
+  if (maxChunk <= 0)
+    return;
+
+  for (int offset = 0; offset < numSamples; offset += maxChunk) {
+    const int chunk = std::min(maxChunk, numSamples - offset);
+    processChunk(engine, inputSilent ? silenceScratch.data() : input + offset,
+                 wet.data() + offset, chunk);
+  }
+}
+
+void SpectralConvolverAudioProcessor::processChunk(ChannelEngine &engine,
+                                                   const float *input,
+                                                   float *wet,
+                                                   int numSamples) {
+  if (engine.diffuse) {
+    const float *diffuseInput = input;
+    if (engine.diffuseDelay) {
+      engine.diffuseDelay->processBlock(input, delayScratch.data(),
+                                        static_cast<std::size_t>(numSamples));
+      diffuseInput = delayScratch.data();
+    }
+
+    const auto y = engine.diffuse->processBlock(diffuseInput, numSamples);
+    for (int i = 0; i < std::min(static_cast<int>(y.size()), numSamples); ++i)
+      wet[i] += y[static_cast<size_t>(i)];
+  }
+
+  if (engine.decimated) {
+    engine.decimatedDelay->processBlock(input, delayScratch.data(),
+                                        static_cast<std::size_t>(numSamples));
+    engine.decimated->processBlock(delayScratch.data(), lateScratch.data(),
+                                   numSamples);
+    for (int i = 0; i < numSamples; ++i)
+      wet[i] += lateScratch[static_cast<size_t>(i)];
+  }
+
+  if (engine.earlyTaps) {
+    engine.earlyTaps->processBlock(input, tapScratch.data(),
+                                   static_cast<std::size_t>(numSamples));
+    for (int i = 0; i < numSamples; ++i)
+      wet[i] += tapScratch[static_cast<size_t>(i)];
+  }
+
+  if (engine.lateTail) {
+    engine.lateTail->processBlock(input, lateScratch.data(),
+                                  static_cast<std::size_t>(numSamples));
+    for (int i = 0; i < numSamples; ++i)
+      wet[i] += lateScratch[static_cast<size_t>(i)];
+  }
+}
+
+bool SpectralConvolverAudioProcessor::isEngineIdle(
+    const ChannelEngine &engine) {
+  return (!engine.earlyTaps || engine.earlyTaps->isIdle()) &&
+         (!engine.diffuseDelay || engine.diffuseDelay->isIdle()) &&
+         (!engine.diffuse || engine.diffuse->isIdle()) &&
+         (!engine.decimatedDelay || engine.decimatedDelay->isIdle()) &&
+         (!engine.decimated || engine.decimated->isIdle()) &&
+         (!engine.lateTail || engine.lateTail->isIdle());
+}
+
+int SpectralConvolverAudioProcessor::getDecimationFactor(QualityTier tier) {
+  switch (tier) {
+  case QualityTier::Medium:
+    return 2;
+  case QualityTier::Low:
+    return 4;
+  case QualityTier::High:
+  default:
+    return 1;
+  }
+}
+
+void SpectralConvolverAudioProcessor::setQualityTier(QualityTier tier) {
+  if (qualityTier.exchange(tier) == tier)
+    return;
+
+  if (isPrepared.load())
+    rebuildConvolvers();
+}
+
+void SpectralConvolverAudioProcessor::setHybridTailEnabled(bool enabled) {
+  if (hybridTail.exchange(enabled) == enabled)
+    return;
+
+  // Re-split the IR here, same as a new IR load
+  if (isPrepared.load())
+    rebuildConvolvers();
+}
+
 void SpectralConvolverAudioProcessor::loadImpulseResponse(
     const std::vector<float> &ir) {
+  setImpulseResponse(ir, juce::File(), IRCache::hashSamples(ir));
+}
+
+void SpectralConvolverAudioProcessor::setImpulseResponse(
+    const std::vector<float> &ir, const juce::File &source,
+    const juce::String &hash) {
   if (ir.empty())
     return;
 
-  {
-    const juce::SpinLock::ScopedLockType lock(irLock);
-    currentIR = ir;
-    irLength = static_cast<int>(ir.size());
-  }
+  storeImpulseResponse(ir, source, hash);
 
-  // Flag for rebuild on audio thread (safer than rebuilding here)
-  irPendingRebuild.store(true);
+  // Build the new engines on this thread; the audio thread picks them up
+  // once they're complete. Before prepareToPlay there's nothing to build for.
+  if (isPrepared.load())
+    rebuildConvolvers();
 
   DBG("IR loaded: " << irLength << " samples");
 }
 
+void SpectralConvolverAudioProcessor::storeImpulseResponse(
+    const std::vector<float> &ir, const juce::File &source,
+    const juce::String &hash) {
+  const juce::SpinLock::ScopedLockType lock(irLock);
+  currentIR = ir;
+  irLength = static_cast<int>(ir.size());
+  currentIRFile = source;
+  currentIRHash = hash;
+
+  // Whatever a failed restore left behind is superseded
+  irRestoreError.clear();
+  unresolvedIRState = juce::ValueTree();
+}
+
+juce::String SpectralConvolverAudioProcessor::getIRRestoreError() const {
+  const juce::SpinLock::ScopedLockType lock(irLock);
+  return irRestoreError;
+}
+
 bool SpectralConvolverAudioProcessor::loadImpulseResponseFromFile(
     const juce::File &file) {
+  std::vector<float> ir;
+  if (!decodeImpulseResponse(file, ir))
+    return false;
+
+  // Keep the decoded samples so restoring a session can skip the decode
+  const auto hash = IRCache::hashSamples(ir);
+  irCache.storeSamples(hash, ir);
+
+  setImpulseResponse(ir, file, hash);
+
+  return true;
+}
+
+bool SpectralConvolverAudioProcessor::decodeImpulseResponse(
+    const juce::File &file, std::vector<float> &ir) {
   if (!file.existsAsFile())
     return false;
 
@@ -377,33 +735,233 @@ bool SpectralConvolverAudioProcessor::loadImpulseResponseFromFile(
   reader->read(&irBuffer, 0, numSamples, 0, true, false);
 
   // Convert to vector
-  std::vector<float> ir(irBuffer.getReadPointer(0),
-                        irBuffer.getReadPointer(0) + numSamples);
-
-  loadImpulseResponse(ir);
+  ir.assign(irBuffer.getReadPointer(0),
+            irBuffer.getReadPointer(0) + numSamples);
 
   return true;
 }
 
+juce::String
+SpectralConvolverAudioProcessor::makeSpectrumKey(const juce::String &irHash,
+                                                 const juce::String &segment,
+                                                 int order, bool hybrid,
+                                                 QualityTier tier) const {
+  if (irHash.isEmpty())
+    return {};
+
+  // Everything that changes how the IR is split and resampled
+  const auto descriptor =
+      segment + "|" + juce::String(currentSampleRate) + "|" +
+      juce::String(currentBlockSize) + "|" + juce::String(order) + "|" +
+      (hybrid ? "hybrid" : "full") + "|" +
+      juce::String(static_cast<int>(tier));
+
+  return IRCache::makeSpectrumKey(irHash, descriptor);
+}
+
+void SpectralConvolverAudioProcessor::queueSpectrumForCache(
+    const juce::String &key, const FreqDomainConvolver::Spectrum &spectrum) {
+  if (key.isEmpty())
+    return;
+
+  // Rebuilds can run inside prepareToPlay, which the host may call from its
+  // audio thread, so the disk write is deferred to the message thread
+  {
+    const juce::SpinLock::ScopedLockType lock(pendingLock);
+    pendingSpectra.push_back({key, spectrum});
+  }
+  triggerAsyncUpdate();
+}
+
+void SpectralConvolverAudioProcessor::handleAsyncUpdate() {
+  std::vector<std::pair<juce::String, FreqDomainConvolver::Spectrum>> toWrite;
+  {
+    const juce::SpinLock::ScopedLockType lock(pendingLock);
+    toWrite.swap(pendingSpectra);
+  }
+
+  for (const auto &[key, spectrum] : toWrite)
+    irCache.storeSpectrum(key, spectrum);
+}
+
 bool SpectralConvolverAudioProcessor::hasEditor() const { return true; }
 
 juce::AudioProcessorEditor *SpectralConvolverAudioProcessor::createEditor() {
   return new SpectralConvolverAudioProcessorEditor(*this);
 }
 
+//==============================================================================
+namespace {
+const juce::Identifier stateType("SpectralConvolverState");
+const juce::Identifier irStateType("ImpulseResponse");
+const juce::Identifier versionId("version");
+const juce::Identifier dryWetMixId("dryWetMix");
+const juce::Identifier hybridTailId("hybridTail");
+const juce::Identifier qualityTierId("qualityTier");
+const juce::Identifier embedIRId("embedIR");
+const juce::Identifier pathId("path");
+const juce::Identifier hashId("hash");
+const juce::Identifier lengthId("length");
+const juce::Identifier dataId("data");
+
+// Version 0 was a bare dry/wet float
+constexpr int currentStateVersion = 1;
+} // namespace
+
 void SpectralConvolverAudioProcessor::getStateInformation(
     juce::MemoryBlock &destData) {
-  // Save IR path or data if needed
-  // For now, just save dry/wet mix
-  juce::MemoryOutputStream stream(destData, true);
-  stream.writeFloat(dryWetMix);
+  juce::ValueTree state(stateType);
+  state.setProperty(versionId, currentStateVersion, nullptr);
+  state.setProperty(dryWetMixId, dryWetMix, nullptr);
+  state.setProperty(hybridTailId, hybridTail.load(), nullptr);
+  state.setProperty(qualityTierId, static_cast<int>(qualityTier.load()),
+                    nullptr);
+  state.setProperty(embedIRId, embedIRInState.load(), nullptr);
+
+  std::vector<float> ir;
+  juce::File irFile;
+  juce::String irHash;
+  int length = 0;
+  juce::ValueTree unresolved;
+  {
+    const juce::SpinLock::ScopedLockType lock(irLock);
+    unresolved = unresolvedIRState;
+    // An IR handed over as samples has no file to find it again by, so it
+    // is always embedded
+    if (embedIRInState.load() || currentIRFile == juce::File())
+      ir = currentIR;
+    irFile = currentIRFile;
+    irHash = currentIRHash;
+    length = irLength;
+  }
+
+  // The IR is saved by reference and content hash; the samples themselves
+  // only go in when embedding is on or there is no file to reference
+  if (irHash.isNotEmpty()) {
+    juce::ValueTree irState(irStateType);
+    irState.setProperty(pathId, irFile.getFullPathName(), nullptr);
+    irState.setProperty(hashId, irHash, nullptr);
+    irState.setProperty(lengthId, length, nullptr);
+
+    if (!ir.empty()) {
+      juce::MemoryBlock compressed;
+      {
+        juce::MemoryOutputStream raw(compressed, false);
+        juce::GZIPCompressorOutputStream zipped(raw, 9);
+        zipped.write(ir.data(), ir.size() * sizeof(float));
+      }
+      irState.setProperty(dataId, compressed, nullptr);
+    }
+
+    state.appendChild(irState, nullptr);
+  } else if (unresolved.isValid()) {
+    // The session's IR couldn't be restored here; pass its reference on
+    // untouched so it isn't lost from the session by saving it
+    state.appendChild(unresolved.createCopy(), nullptr);
+  }
+
+  juce::MemoryOutputStream stream(destData, false);
+  state.writeToStream(stream);
 }
 
 void SpectralConvolverAudioProcessor::setStateInformation(const void *data,
                                                           int sizeInBytes) {
-  juce::MemoryInputStream stream(data, static_cast<size_t>(sizeInBytes), false);
-  if (sizeInBytes >= sizeof(float))
+  // Version 0: just the dry/wet mix
+  if (sizeInBytes == static_cast<int>(sizeof(float))) {
+    juce::MemoryInputStream stream(data, static_cast<size_t>(sizeInBytes),
+                                   false);
     dryWetMix = stream.readFloat();
+    return;
+  }
+
+  const auto state =
+      juce::ValueTree::readFromData(data, static_cast<size_t>(sizeInBytes));
+  if (!state.hasType(stateType))
+    return;
+
+  if (static_cast<int>(state.getProperty(versionId, 0)) > currentStateVersion)
+    DBG("State saved by a newer version, restoring what is understood");
+
+  dryWetMix = state.getProperty(dryWetMixId, 1.0f);
+  embedIRInState.store(state.getProperty(embedIRId, false));
+
+  // Settings and IR are stored first and the engines built once at the end,
+  // rather than once per setter against an IR that is about to be replaced
+  const bool hybrid = state.getProperty(hybridTailId, false);
+  const auto tier = static_cast<QualityTier>(juce::jlimit(
+      static_cast<int>(QualityTier::High), static_cast<int>(QualityTier::Low),
+      static_cast<int>(state.getProperty(qualityTierId, 0))));
+
+  bool needsRebuild = hybridTail.exchange(hybrid) != hybrid;
+  needsRebuild = qualityTier.exchange(tier) != tier || needsRebuild;
+
+  const auto irState = state.getChildWithName(irStateType);
+  if (irState.isValid()) {
+    restoreImpulseResponse(irState);
+    needsRebuild = true;
+  }
+
+  if (needsRebuild && isPrepared.load())
+    rebuildConvolvers();
+}
+
+void SpectralConvolverAudioProcessor::restoreImpulseResponse(
+    const juce::ValueTree &irState) {
+  const juce::String hash = irState.getProperty(hashId);
+  const juce::String path = irState.getProperty(pathId);
+  const juce::File file = path.isNotEmpty() ? juce::File(path) : juce::File();
+
+  // Leave no IR loaded rather than keep playing (and saving) the previous
+  // one as if it were the session's, and hold on to the saved reference so
+  // the next save writes it back
+  const auto fail = [this, &irState](const juce::String &message) {
+    juce::Logger::writeToLog("SpectralConvolver: " + message);
+    storeImpulseResponse({}, {}, {});
+
+    auto unresolved = irState.createCopy();
+    const juce::SpinLock::ScopedLockType lock(irLock);
+    irRestoreError = message;
+    unresolvedIRState = unresolved;
+  };
+
+  std::vector<float> ir;
+
+  // 1. Embedded copy
+  if (const auto *block = irState.getProperty(dataId).getBinaryData()) {
+    juce::MemoryInputStream raw(*block, false);
+    juce::GZIPDecompressorInputStream unzipped(raw);
+    juce::MemoryBlock samples;
+    unzipped.readIntoMemoryBlock(samples);
+
+    ir.resize(samples.getSize() / sizeof(float));
+    samples.copyTo(ir.data(), 0, ir.size() * sizeof(float));
+
+    if (IRCache::hashSamples(ir) != hash)
+      ir.clear();
+  }
+
+  // 2. Samples decoded by an earlier session
+  if (ir.empty())
+    irCache.loadSamples(hash, ir);
+
+  // 3. Decode the referenced file. If it no longer holds the samples the
+  // session was saved with, loading it would quietly change the sound, so
+  // it is refused and reported instead.
+  if (ir.empty() && decodeImpulseResponse(file, ir)) {
+    if (IRCache::hashSamples(ir) != hash) {
+      fail("IR file has changed since the session was saved: " + path);
+      return;
+    }
+
+    irCache.storeSamples(hash, ir);
+  }
+
+  if (ir.empty()) {
+    fail("Could not restore IR: " + path);
+    return;
+  }
+
+  storeImpulseResponse(ir, file, hash);
 }
 
 juce::AudioProcessor *JUCE_CALLTYPE createPluginFilter() {
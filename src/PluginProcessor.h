@@ -2,10 +2,15 @@
 
 #include <JuceHeader.h>
 #include "FreqDomainConvolver.h"
+#include "SparseTapConvolver.h"
+#include "LateReverbGenerator.h"
+#include "MultirateConvolver.h"
+#include "IRCache.h"
 #include <memory>
 #include <vector>
 
-class SpectralConvolverAudioProcessor : public juce::AudioProcessor
+class SpectralConvolverAudioProcessor : public juce::AudioProcessor,
+                                        private juce::AsyncUpdater
 {
 public:
     SpectralConvolverAudioProcessor();
@@ -49,26 +54,154 @@ public:
     bool isIRLoaded() const { return irLoaded.load(); }
     
     int getIRLength() const { return irLength; }
+    
+    // Why the last session restore left its IR unloaded (missing, or the
+    // file at the saved path has different contents); empty otherwise.
+    // Until a new IR is loaded the plugin runs with no IR and keeps saving
+    // the session's original IR reference.
+    juce::String getIRRestoreError() const;
+    
+    // Hybrid mode: convolve the first 300 ms exactly (less where that won't
+    // fit one FFT) and synthesize the rest of the tail from the IR's
+    // measured per-band decay
+    void setHybridTailEnabled (bool enabled);
+    
+    bool isHybridTailEnabled() const { return hybridTail.load(); }
+    
+    // Lower tiers convolve the IR past the first 80 ms at a reduced rate,
+    // trading some high end in the tail for CPU
+    enum class QualityTier
+    {
+        High,    // everything at the host rate
+        Medium,  // late part at 1/2 rate
+        Low      // late part at 1/4 rate
+    };
+    
+    void setQualityTier (QualityTier tier);
+    
+    QualityTier getQualityTier() const { return qualityTier.load(); }
+    
+    // Saved state always references the IR file and its content hash; with
+    // this on it also carries a compressed copy of the samples, so the
+    // session restores even if the file is gone. IRs loaded from memory
+    // rather than a file are always embedded.
+    void setEmbedIRInState (bool shouldEmbed) { embedIRInState.store (shouldEmbed); }
+    
+    bool isIREmbeddedInState() const { return embedIRInState.load(); }
 
 private:
     
+    // Largest full-rate FFT (16384 points)
+    static constexpr int maxFFTOrder = 14;
+    
     static int calculateFFTOrder (int irLength, int blockSize);
     
+    static int getDecimationFactor (QualityTier tier);
+    
+    void setImpulseResponse (const std::vector<float>& ir, const juce::File& source,
+                             const juce::String& hash);
+    
+    // Swap in a new IR (empty for none) without rebuilding the engines
+    void storeImpulseResponse (const std::vector<float>& ir, const juce::File& source,
+                               const juce::String& hash);
+    
+    static bool decodeImpulseResponse (const juce::File& file, std::vector<float>& ir);
+    
+    // Embedded copy first, then the decoded-sample cache, then the file.
+    // Only stores the IR; the caller rebuilds the engines.
+    void restoreImpulseResponse (const juce::ValueTree& irState);
+    
+    // Cache key for one IR spectrum built with these settings; empty if the
+    // IR has no hash. Settings are passed in rather than read from the
+    // atomics, so the key always matches what the spectrum was built with.
+    juce::String makeSpectrumKey (const juce::String& irHash, const juce::String& segment,
+                                  int order, bool hybrid, QualityTier tier) const;
+    
+    void queueSpectrumForCache (const juce::String& key,
+                                const FreqDomainConvolver::Spectrum& spectrum);
+    
+    void handleAsyncUpdate() override;
+    
+    // Build a fresh set of engines from the current IR and settings, off the
+    // audio thread, and swap them in
     void rebuildConvolvers();
     
+    // Per-channel processing chain. Early reflections run through the sparse
+    // tap engine; the diffuse remainder is delayed to its offset in the IR and
+    // convolved by the FFT engine, with its late part at a reduced rate on
+    // lower quality tiers. In hybrid mode the late tail comes from the
+    // generator instead. Any part may be absent.
+    struct ChannelEngine
+    {
+        std::unique_ptr<SparseTapConvolver> earlyTaps;
+        std::unique_ptr<SparseTapConvolver> diffuseDelay;
+        std::unique_ptr<FreqDomainConvolver> diffuse;
+        std::unique_ptr<SparseTapConvolver> decimatedDelay;
+        std::unique_ptr<MultirateConvolver> decimated;
+        std::unique_ptr<LateReverbGenerator> lateTail;
+    };
+    
+    void processChannel (ChannelEngine& engine, const float* input, bool inputSilent,
+                         std::vector<float>& wet, int numSamples);
+    
+    // One piece of a channel block, no longer than the prepared block size
+    void processChunk (ChannelEngine& engine, const float* input,
+                       float* wet, int numSamples);
+    
+    std::vector<ChannelEngine> buildEngines (const std::vector<float>& ir,
+                                             const juce::String& irHash,
+                                             const LateReverbGenerator::DecayProfile& tailProfile,
+                                             QualityTier tier);
+    
+    // Decay analysis for hybrid mode, reused across rebuilds of the same IR
+    // at the same rate. Only called from rebuildConvolvers.
+    LateReverbGenerator::DecayProfile getDecayProfile (const std::vector<float>& ir,
+                                                       const juce::String& irHash);
     
-    std::vector<std::unique_ptr<FreqDomainConvolver>> convolvers;
+    // True when no part of the engine has any tail left to emit
+    static bool isEngineIdle (const ChannelEngine& engine);
+    
+    // Input blocks peaking below this (-140 dBFS) count as silent
+    static constexpr float silenceThreshold = 1.0e-7f;
+    
+    std::vector<ChannelEngine> engines;
+    
+    // Scratch space for processChannel, sized to the prepared block size
+    std::vector<float> wetScratch, tapScratch, delayScratch, lateScratch;
+    std::vector<float> silenceScratch;
     
     std::vector<float> currentIR;
     int irLength = 0;
+    juce::File currentIRFile;
+    juce::String currentIRHash;
+    juce::String irRestoreError;
+    // IR reference from a restored session that couldn't be loaded, saved
+    // back unchanged until another IR replaces it
+    juce::ValueTree unresolvedIRState;
+    std::atomic<bool> embedIRInState { false };
+    
+    IRCache irCache;
+    
+    // Spectra computed during a rebuild, written to the cache on the message thread
+    std::vector<std::pair<juce::String, FreqDomainConvolver::Spectrum>> pendingSpectra;
+    juce::SpinLock pendingLock;
     std::atomic<bool> irLoaded { false };
     
     double currentSampleRate = 44100.0;
     int currentBlockSize = 512;
-    int fftOrder = 10;
+    std::atomic<bool> isPrepared { false };
+    
+    // irLock guards what the audio thread reads; rebuildLock serialises
+    // rebuilds, which run on whichever thread changed the IR or settings
+    mutable juce::SpinLock irLock;
+    juce::CriticalSection rebuildLock;
     
-    juce::SpinLock irLock;
-    std::atomic<bool> irPendingRebuild { false };
+    // Last decay analysis and the IR hash and rate it was made for;
+    // guarded by rebuildLock
+    LateReverbGenerator::DecayProfile decayProfile;
+    juce::String decayProfileKey;
+    std::atomic<bool> hybridTail { false };
+    std::atomic<QualityTier> qualityTier { QualityTier::High };
     
     float dryWetMix = 1.0f;  // 1.0 = 100% wet
     
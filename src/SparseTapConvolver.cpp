@@ -0,0 +1,138 @@
+#include "SparseTapConvolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // A sample counts as a reflection if it is within -20 dB of the IR peak
+    constexpr float       tapThreshold      = 0.1f;
+    // More than this many reflections inside one window marks the diffuse onset
+    constexpr std::size_t densityWindow     = 64;
+    constexpr std::size_t maxTapsPerWindow  = 6;
+    // Keep the tap engine cheap to run
+    constexpr std::size_t maxTaps           = 64;
+}
+
+SparseTapConvolver::Split SparseTapConvolver::splitIR(const std::vector<float>& ir, std::size_t maxEarlySamples)
+{
+    Split split;
+    split.diffuse = ir;
+
+    float peak = 0.0f;
+    for (float s : ir)
+        peak = std::max(peak, std::abs(s));
+    if (peak <= 0.0f)
+        return split;
+
+    const float threshold = peak * tapThreshold;
+    const std::size_t earlyLimit = std::min(maxEarlySamples, ir.size());
+
+    // Walk a window over the early part, counting reflections. Once they bunch
+    // up the IR has gone diffuse and the window start is where taps stop.
+    std::size_t onset = earlyLimit;
+    std::size_t inWindow = 0;
+    for (std::size_t n = 0; n < earlyLimit; n++)
+    {
+        if (std::abs(ir[n]) >= threshold)
+            inWindow++;
+        if (n >= densityWindow && std::abs(ir[n - densityWindow]) >= threshold)
+            inWindow--;
+
+        if (inWindow > maxTapsPerWindow)
+        {
+            onset = (n + 1 > densityWindow) ? n + 1 - densityWindow : 0;
+            break;
+        }
+    }
+
+    if (onset == 0)
+        return split;
+
+    std::vector<Tap> taps;
+    for (std::size_t n = 0; n < onset; n++)
+        if (std::abs(ir[n]) >= threshold)
+            taps.push_back({ n, ir[n] });
+
+    if (taps.empty() || taps.size() > maxTaps)
+        return split;
+
+    // Everything that isn't a tap stays with the FFT engine: the remainder is
+    // the IR with the tap samples zeroed, so taps + remainder is exact. Any
+    // low-level build-up between the reflections is still convolved.
+    std::vector<float> residual(ir);
+    for (const auto& tap : taps)
+        residual[tap.delay] = 0.0f;
+
+    // Leading silence is covered for free by the delay line in front of the
+    // FFT engine
+    const auto tailStart = std::find_if(residual.begin(), residual.end(),
+                                        [](float s) { return s != 0.0f; });
+    const std::size_t offset = (std::size_t)(tailStart - residual.begin());
+
+    // Nothing to gain unless the taps shorten what the FFT engine covers.
+    // Whether that buys a smaller FFT depends on the block size, so the
+    // caller makes the final call.
+    if (offset <= taps.front().delay)
+        return split;
+
+    split.taps = std::move(taps);
+    split.diffuseOffset = offset;
+    split.diffuse.assign(tailStart, residual.end());
+
+    return split;
+}
+
+SparseTapConvolver::SparseTapConvolver(const std::vector<Tap>& inputTaps)
+    : taps(inputTaps), maxDelay(0), writeIndex(0), silentSamples(0)
+{
+    if (taps.empty()) throw std::invalid_argument("Tap list cannot be empty");
+
+    for (const auto& tap : taps)
+        maxDelay = std::max(maxDelay, tap.delay);
+
+    delayBuffer.assign(maxDelay + 1, 0.0f);
+    silentSamples = delayBuffer.size();
+}
+
+void SparseTapConvolver::reset()
+{
+    std::fill(delayBuffer.begin(), delayBuffer.end(), 0.0f);
+    writeIndex = 0;
+    silentSamples = delayBuffer.size();
+}
+
+float SparseTapConvolver::processSample(float x)
+{
+    // Same circular delay line as TimeDomainConvolver, but only the tap
+    // positions are read back instead of every IR sample
+    const std::size_t bufferSize = delayBuffer.size();
+    delayBuffer[writeIndex] = x;
+    silentSamples = (x == 0.0f) ? silentSamples + 1 : 0;
+
+    float sum = 0.0f;
+    for (const auto& tap : taps)
+    {
+        const std::size_t readIndex = (writeIndex >= tap.delay)
+                                          ? writeIndex - tap.delay
+                                          : writeIndex + bufferSize - tap.delay;
+        sum += tap.gain * delayBuffer[readIndex];
+    }
+
+    writeIndex = (writeIndex + 1) % bufferSize;
+
+    return sum;
+}
+
+void SparseTapConvolver::processBlock(const float* in, float* out, std::size_t numSamples)
+{
+    // Nothing in the delay line and nothing coming in: every tap reads zero
+    if (isIdle() && std::all_of(in, in + numSamples, [](float s) { return s == 0.0f; }))
+    {
+        std::fill(out, out + numSamples, 0.0f);
+        return;
+    }
+
+    for (std::size_t n = 0; n < numSamples; n++)
+        out[n] = processSample(in[n]);
+}
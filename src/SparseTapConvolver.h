@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <stdexcept>
+
+class SparseTapConvolver {
+public:
+    struct Tap
+    {
+        std::size_t delay;
+        float       gain;
+    };
+
+    // Result of IR analysis: discrete early reflections as taps, plus the
+    // diffuse remainder that still needs dense convolution. The remainder
+    // starts diffuseOffset samples into the original IR.
+    struct Split
+    {
+        std::vector<Tap>   taps;
+        std::vector<float> diffuse;
+        std::size_t        diffuseOffset = 0;
+    };
+
+    // Scan the first maxEarlySamples of the IR for isolated reflections.
+    // If the early part is sparse enough to be carried by a few taps, they are
+    // extracted and the remainder is the IR with those samples zeroed, so the
+    // two sum back to the original exactly. Otherwise the whole IR comes back
+    // as the remainder with no taps. A split is only worth running if the
+    // shorter remainder needs a smaller FFT; the caller checks that.
+    static Split splitIR(const std::vector<float>& ir, std::size_t maxEarlySamples);
+
+    SparseTapConvolver(const std::vector<Tap>& taps);
+    void reset();
+    float processSample(float x);
+    void processBlock(const float* in, float* out, std::size_t numSamples);
+
+    std::size_t getNumTaps()  const { return taps.size(); }
+    std::size_t getMaxDelay() const { return maxDelay; }
+
+    // True once the delay line holds nothing but zeros
+    bool isIdle() const { return silentSamples >= delayBuffer.size(); }
+
+private:
+    std::vector<Tap>   taps;
+    std::size_t        maxDelay;
+    std::vector<float> delayBuffer;
+    std::size_t        writeIndex;
+    std::size_t        silentSamples;
+};